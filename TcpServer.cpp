@@ -1,6 +1,8 @@
 #include "TcpServer.h"
+#include <algorithm>
 #include <chrono>
 #include <cstring>
+#include <iostream>
 #include <mutex>
 #include <utility>
 
@@ -84,6 +86,15 @@ inline int convertError() {
 }
 
 #else
+#include <cctype>
+#include <cerrno>
+#include <poll.h>
+#include <pthread.h>
+#ifdef __linux__
+#include <dirent.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
 // Макросы для выражений зависимых от OS
 #define WIN(exp)
 #define NIX(exp) exp
@@ -123,6 +134,37 @@ TcpServer::~TcpServer() {
 // Setter обработчика данных
 void TcpServer::setHandler(TcpServer::handler_function_t handler) {this->handler = handler;}
 
+// Setter конфигурации защиты от перегрузки
+void TcpServer::setOverloadConfig(OverloadConfig overload_conf) {
+  std::lock_guard<std::mutex> lock(overload_mutex);
+  this->overload_conf = overload_conf;
+}
+
+// Setter обработчика отклонённых кадров
+void TcpServer::setRejectHandler(handler_function_t reject_hndl) {this->reject_hndl = reject_hndl;}
+
+// Получить снимок метрик защиты от перегрузки
+OverloadStats TcpServer::getOverloadStats() {
+  std::lock_guard<std::mutex> lock(overload_mutex);
+  OverloadStats stats = overload_stats;
+  stats.shedding_clients = shedding_clients;
+  stats.shedding = stats.shedding_clients;
+  return stats;
+}
+
+// Setter пакетного обработчика данных
+void TcpServer::setBatchHandler(batch_handler_function_t batch_hndl, BatchConfig batch_conf) {
+  this->batch_hndl = batch_hndl;
+  this->batch_conf = batch_conf;
+  if(!this->batch_conf.max_batch) this->batch_conf.max_batch = 1;
+}
+
+// Setter конфигурации размещения потоков и режима низкой задержки
+void TcpServer::setPerformanceConfig(PerformanceConfig perf_conf) {this->perf_conf = perf_conf;}
+
+// Setter лимита очереди исходящих кадров клиента
+void TcpServer::setOutputLimit(size_t output_limit) {this->output_limit = output_limit;}
+
 // Getter порта
 uint16_t TcpServer::getPort() const {return port;}
 // Setter порта
@@ -167,10 +209,25 @@ TcpServer::status TcpServer::start() {
     return _status = status::err_socket_listening;
 
   _status = status::up;
+  checkWorkerNodes();
   // Запускаем поток ожидания соединений
-  accept_handler_thread = std::thread([this]{handlingAcceptLoop();});
+  accept_handler_thread = std::thread([this]{
+    placeThread(perf_conf.accept_cpu);
+    placeSharedMemory();
+    handlingAcceptLoop();
+  });
   // Запускаем поток ожидания данных
-  data_waiter_thread = std::thread([this]{waitingDataLoop();});
+  data_waiter_thread = std::thread([this]{
+    placeThread(perf_conf.data_loop_cpu);
+    placeSharedMemory();
+    waitingDataLoop();
+  });
+  // Запускаем поток пакетной обработки кадров разных клиентов
+  if(batch_hndl && batch_conf.cross_client)
+    batch_worker_thread = std::thread([this]{
+      placeWorkerThread();
+      batchWorkerLoop();
+    });
   return _status;
 }
 
@@ -178,7 +235,8 @@ TcpServer::status TcpServer::start() {
 // Реализация остановки сервера
 void TcpServer::stop() {
   _status = status::close;
-  // Закрываем сокет
+  // Закрываем сокет (shutdown прерывает ожидание в accept)
+  shutdown(serv_socket, WIN(SD_BOTH)NIX(SHUT_RDWR));
   WIN(closesocket)NIX(close)(serv_socket);
   // Ожидаем завершения потоков
   joinLoop();
@@ -187,7 +245,11 @@ void TcpServer::stop() {
 }
 
 // "Вхождение" в потоки ожидания
-void TcpServer::joinLoop() {accept_handler_thread.join(); data_waiter_thread.join();}
+void TcpServer::joinLoop() {
+  accept_handler_thread.join();
+  data_waiter_thread.join();
+  if(batch_worker_thread.joinable()) batch_worker_thread.join();
+}
 
 // Создание подключение со стороны сервера
 // (подключение аналогично клиентоскому, но обрабатывается
@@ -219,8 +281,10 @@ bool TcpServer::connectTo(uint32_t host, uint16_t port, con_handler_function_t c
     shutdown(client_socket, 0);
     WIN(closesocket)NIX(close)(client_socket);
   }
+  enableBusyPoll(client_socket);
 
   std::unique_ptr<Client> client(new Client(client_socket, address));
+  client->output_limit = output_limit;
   // Запуск обработчика подключения
   connect_hndl(*client);
   // Добавление клиента в список клиентов
@@ -248,6 +312,90 @@ bool TcpServer::sendDataBy(uint32_t host, uint16_t port, const void* buffer, con
   return data_is_sended;
 }
 
+// Добавление клиента в группу топика
+// (набор участников копируется, поэтому текущие рассылки
+// продолжают работать со своим снимком)
+bool TcpServer::join(Client& client, const std::string& topic) {
+  std::lock_guard<std::mutex> lock(group_mutex);
+  GroupMembers& members = groups[topic];
+  std::vector<Client*> updated;
+  if(members) updated = *members;
+  auto pos = std::lower_bound(updated.begin(), updated.end(), &client);
+  if(pos != updated.end() && *pos == &client) return false;
+  updated.insert(pos, &client);
+  members = std::make_shared<const std::vector<Client*>>(std::move(updated));
+  client.topics.push_back(topic);
+  return true;
+}
+
+// Исключение клиента из группы топика
+bool TcpServer::leave(Client& client, const std::string& topic) {
+  std::lock_guard<std::mutex> lock(group_mutex);
+  auto group = groups.find(topic);
+  if(group == groups.end()) return false;
+  std::vector<Client*> updated = *group->second;
+  auto pos = std::lower_bound(updated.begin(), updated.end(), &client);
+  if(pos == updated.end() || *pos != &client) return false;
+  updated.erase(pos);
+  if(updated.empty()) groups.erase(group);
+  else group->second = std::make_shared<const std::vector<Client*>>(std::move(updated));
+  client.topics.erase(std::find(client.topics.begin(), client.topics.end(), topic));
+  return true;
+}
+
+// Исключение клиента из всех его групп
+void TcpServer::leaveAll(Client& client) {
+  std::lock_guard<std::mutex> lock(group_mutex);
+  for(const std::string& topic : client.topics) {
+    auto group = groups.find(topic);
+    if(group == groups.end()) continue;
+    std::vector<Client*> updated = *group->second;
+    updated.erase(std::lower_bound(updated.begin(), updated.end(), &client));
+    if(updated.empty()) groups.erase(group);
+    else group->second = std::make_shared<const std::vector<Client*>>(std::move(updated));
+  }
+  client.topics.clear();
+}
+
+// Отправка данных всем клиентам группы топика
+size_t TcpServer::publish(const std::string& topic, const void* buffer, const size_t size,
+                          con_handler_function_t skip_hndl) {
+  GroupMembers members;
+  group_mutex.lock();
+  if(auto group = groups.find(topic); group != groups.end()) {
+    members = group->second;
+    // Участники снимка не будут удалены до конца рассылки
+    for(Client* client : *members)
+      ++client->publish_refs;
+  }
+  group_mutex.unlock();
+  if(!members) return 0;
+
+  // Кадр (размер + данные) формируется один раз для всех участников
+  std::shared_ptr<std::vector<char>> frame = std::make_shared<std::vector<char>>(sizeof(uint32_t) + size);
+  uint32_t net_size = htonl(static_cast<uint32_t>(size));
+  memcpy(frame->data(), &net_size, sizeof(net_size));
+  memcpy(frame->data() + sizeof(net_size), buffer, size);
+
+  // Кадр ставится в очередь каждого участника и записывается без блокировки,
+  // поэтому медленный участник не задерживает остальных
+  size_t sended = 0;
+  for(Client* client : *members) {
+    if(client->sendFrame(frame))
+      ++sended;
+    else {
+      if(client->_status == SocketStatus::connected) {
+        std::lock_guard<std::mutex> lock(overload_mutex);
+        ++overload_stats.dropped_output_frames;
+      }
+      if(skip_hndl) skip_hndl(*client);
+    }
+    // После уменьшения счётчика клиент может быть удалён
+    --client->publish_refs;
+  }
+  return sended;
+}
+
 // Отключение клиента по конкретному хосту и порту
 bool TcpServer::disconnectBy(uint32_t host, uint16_t port) {
   bool client_is_disconnected = false;
@@ -272,6 +420,12 @@ void TcpServer::handlingAcceptLoop() {
   SockLen_t addrlen = sizeof(SocketAddr_in);
   // Пока сервер запущен
   while (_status == status::up) {
+    using namespace std::chrono_literals;
+    // При перегрузке новые подключения остаются в очереди listen
+    if(shedding_clients) {
+      std::this_thread::sleep_for(10ms);
+      continue;
+    }
     SocketAddr_in client_addr;
     // Принятеи новго подключения (блокирующи вызов)
     if (Socket client_socket = accept(serv_socket, (struct sockaddr*)&client_addr, &addrlen);
@@ -279,13 +433,24 @@ void TcpServer::handlingAcceptLoop() {
       // Если получен сокет с ошибкой продолжить ожидание
       if(client_socket == WIN(INVALID_SOCKET)NIX(-1)) continue;
 
+      // Если перегрузка началась во время ожидания accept - отклонить подключение
+      if(shedding_clients) {
+        shutdown(client_socket, 0);
+        WIN(closesocket)NIX(close)(client_socket);
+        std::lock_guard<std::mutex> lock(overload_mutex);
+        ++overload_stats.refused_connections;
+        continue;
+      }
+
       // Активировать Keep-Alive для клиента
       if(!enableKeepAlive(client_socket)) {
         shutdown(client_socket, 0);
         WIN(closesocket)NIX(close)(client_socket);
       }
+      enableBusyPoll(client_socket);
 
       std::unique_ptr<Client> client(new Client(client_socket, client_addr));
+      client->output_limit = output_limit;
       // Запустить обработчик подключений
       connect_hndl(*client);
       // Добавить клиента в список клиентов
@@ -299,23 +464,75 @@ void TcpServer::handlingAcceptLoop() {
 
 // Цикл ожидания данных
 void TcpServer::waitingDataLoop() {
-  using namespace std::chrono_literals;
-  while (true) {
+  // Начало текущего активного ожидания данных
+  std::chrono::steady_clock::time_point spin_start;
+  bool spinning = false;
+  // Сокеты для блокирующего ожидания данных
+  std::vector<pollfd> poll_fds;
+  while (_status == status::up) {
+    bool has_data = false;
+    poll_fds.clear();
+    // Завершить истёкшие интервалы оценки клиентов, даже если их кадры
+    // не обрабатываются (проверка не чаще 1/10 интервала)
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    bool check_overload = overload_conf.enabled &&
+      now - last_overload_check >= std::max<std::chrono::steady_clock::duration>(
+        overload_conf.interval / 10, std::chrono::milliseconds(1));
+    if(check_overload) last_overload_check = now;
     client_mutex.lock();
     // Перебрать всех клиентов
     for(auto it = client_list.begin(), end = client_list.end(); it != end; ++it) {
       auto& client = *it;
       // Если unique_ptr содержит объект клиента
       if(client){
-        if(DataBuffer data = client->loadData(); data.size) {
-          // При наличии данных запустить обработку входящих данных в отдельном потоке
-          std::thread([this, _data = std::move(data), &client]{
-            client->access_mtx.lock();
-            handler(_data, *client);
-            client->access_mtx.unlock();
-          }).detach();
-        } else if(client->_status == SocketStatus::disconnected) {
-          // При отключении клиента запустить обработку в отдельном потоке
+        if(check_overload && !client->cleanup_scheduled) {
+          std::lock_guard<std::mutex> lock(overload_mutex);
+          checkOverload(*client, now);
+        }
+        // Приостановить чтение от перегруженного клиента
+        if(client->overloaded && !overload_conf.reject_frames &&
+           client->_status == SocketStatus::connected) {
+          if(!client->reads_paused) {
+            client->reads_paused = true;
+            std::lock_guard<std::mutex> lock(overload_mutex);
+            ++overload_stats.paused_reads;
+          }
+          continue;
+        }
+        client->reads_paused = false;
+        // Дописать исходящие кадры, не записанные без блокировки
+        if(client->has_output)
+          client->flushQueue();
+        if(client->_status == SocketStatus::connected)
+          poll_fds.push_back(pollfd{client->socket, short(POLLIN | (client->has_output ? POLLOUT : 0)), 0});
+        // Не блокироваться на клиентах без поступивших данных
+        if(client->_status == SocketStatus::connected && !client->hasData())
+          continue;
+        if(DataBuffer data = client->loadReadyData(); data.size) {
+          has_data = true;
+          // При перегрузке клиента отклонить кадр через обработчик
+          if(client->overloaded && overload_conf.reject_frames) {
+            overload_mutex.lock();
+            ++overload_stats.rejected_frames;
+            overload_mutex.unlock();
+            reject_hndl(std::move(data), *client);
+            continue;
+          }
+          // При наличии данных поставить их в очередь обработки клиента
+          dispatchFrames(*client, std::move(data));
+        } else if(client->_status == SocketStatus::disconnected &&
+                  !client->pending_frames && !client->cleanup_scheduled &&
+                  client->isIdle()) {
+          client->cleanup_scheduled = true;
+          // Кадров клиента больше не будет - снять признак перегрузки
+          overload_mutex.lock();
+          if(client->overloaded) {
+            client->overloaded = false;
+            --shedding_clients;
+          }
+          overload_mutex.unlock();
+          // При отключении клиента (после обработки всех его кадров)
+          // запустить обработку в отдельном потоке
           std::thread([this, &client, it]{
             // Извлечь объект клиента из unique_ptr в списке
             client->access_mtx.lock();
@@ -324,8 +541,14 @@ void TcpServer::waitingDataLoop() {
             pointer->access_mtx.unlock();
             // Запуск обработчика отключения
             disconnect_hndl(*pointer);
+            // Исключить клиента из групп и дождаться завершения текущих рассылок
+            leaveAll(*pointer);
+            while(pointer->publish_refs)
+              std::this_thread::yield();
             // Удалить элемент клиента из списка
+            client_mutex.lock();
             client_list.erase(it);
+            client_mutex.unlock();
             // Удалить объект клиента
             delete pointer;
           }).detach();
@@ -333,10 +556,207 @@ void TcpServer::waitingDataLoop() {
       }
     }
     client_mutex.unlock();
-    // Ожидание 50 млисекунд так как в данном потоке
-    // не содержится блокирующих вызовов и данный
-    // цикл сильно повышает загруженность CPU
-    std::this_thread::sleep_for(50ms);
+    if(has_data) {
+      spinning = false;
+      continue;
+    }
+    // В режиме низкой задержки данные ожидаются активно в течение busy_poll
+    if(perf_conf.busy_poll.count()) {
+      now = std::chrono::steady_clock::now();
+      if(!spinning) {
+        spinning = true;
+        spin_start = now;
+      }
+      if(now - spin_start < perf_conf.busy_poll) {
+        std::this_thread::yield();
+        continue;
+      }
+      spinning = false;
+    }
+    // Блокирующее ожидание данных (не дольше idle_sleep, чтобы
+    // учесть новых клиентов) вместо холостого цикла, который
+    // сильно повышает загруженность CPU
+    if(poll_fds.empty())
+      std::this_thread::sleep_for(perf_conf.idle_sleep);
+    else
+      WIN(WSAPoll)NIX(poll)(poll_fds.data(), poll_fds.size(), int(perf_conf.idle_sleep.count()));
+  }
+}
+
+// Учёт времени ожидания кадра в детекторе перегрузки клиента.
+// Пока клиент перегружен, кадры, ожидавшие дольше target, отклоняются
+bool TcpServer::onFrameStart(Client& client, std::chrono::steady_clock::duration sojourn) {
+  using namespace std::chrono;
+  --client.queued_frames;
+  std::lock_guard<std::mutex> lock(overload_mutex);
+  overload_stats.last_sojourn = duration_cast<microseconds>(sojourn);
+  if(!overload_conf.enabled) return false;
+
+  client.interval_min = std::min(client.interval_min, sojourn);
+  checkOverload(client, steady_clock::now());
+  if(!client.overloaded || sojourn < overload_conf.target) return false;
+  ++overload_stats.rejected_frames;
+  return true;
+}
+
+// Детектор перегрузки клиента: по завершении каждого interval клиент
+// считается перегруженным, если даже минимальное время ожидания его
+// кадров за интервал не ниже target, и перестаёт, если минимум опустился
+// ниже target. Если за интервал кадры не обрабатывались, перегрузка
+// снимается только при пустой очереди клиента
+void TcpServer::checkOverload(Client& client, std::chrono::steady_clock::time_point now) {
+  if(now - client.interval_start < overload_conf.interval) return;
+
+  bool overloaded = client.interval_min == std::chrono::steady_clock::duration::max()
+                      ? client.overloaded && client.queued_frames
+                      : client.interval_min >= overload_conf.target;
+  if(overloaded != client.overloaded) {
+    client.overloaded = overloaded;
+    if(overloaded) {
+      ++shedding_clients;
+      ++overload_stats.shed_events;
+    } else --shedding_clients;
+  }
+  client.interval_start = now;
+  client.interval_min = std::chrono::steady_clock::duration::max();
+}
+
+// Постановка кадров клиента в очередь обработки
+void TcpServer::dispatchFrames(Client& client, DataBuffer data) {
+  std::chrono::steady_clock::time_point queued = std::chrono::steady_clock::now();
+  std::vector<Frame> frames;
+  frames.push_back(Frame{std::move(data), &client, queued});
+  // Для пакетного обработчика дочитать полностью поступившие кадры
+  while(batch_hndl && frames.size() < batch_conf.max_batch) {
+    DataBuffer next = client.loadReadyData();
+    if(!next.size) break;
+    frames.push_back(Frame{std::move(next), &client, queued});
+  }
+  client.pending_frames += frames.size();
+  client.queued_frames += frames.size();
+
+  // Пакеты из кадров разных клиентов собирает поток пакетной обработки
+  if(batch_hndl && batch_conf.cross_client) {
+    batch_mutex.lock();
+    for(Frame& frame : frames)
+      batch_queue.push_back(std::move(frame));
+    batch_mutex.unlock();
+    batch_cv.notify_one();
+    return;
+  }
+
+  // Иначе кадры обрабатывает поток клиента, чтобы сохранить их порядок
+  client.in_mtx.lock();
+  for(Frame& frame : frames)
+    client.in_queue.push_back(std::move(frame));
+  bool start_worker = !client.worker_active;
+  client.worker_active = true;
+  client.in_mtx.unlock();
+  if(start_worker)
+    std::thread([this, &client]{
+      placeWorkerThread();
+      clientWorkerLoop(client);
+    }).detach();
+}
+
+// Цикл потока обработки кадров клиента: завершается, когда очередь пуста
+void TcpServer::clientWorkerLoop(Client& client) {
+  while(true) {
+    std::vector<Frame> frames;
+    {
+      std::lock_guard<std::mutex> lock(client.in_mtx);
+      if(client.in_queue.empty()) {
+        // После сброса флага клиент может быть удалён
+        client.worker_active = false;
+        return;
+      }
+      size_t count = batch_hndl ? std::min(client.in_queue.size(), batch_conf.max_batch) : 1;
+      frames.reserve(count);
+      for(size_t i = 0; i < count; ++i) {
+        frames.push_back(std::move(client.in_queue.front()));
+        client.in_queue.pop_front();
+      }
+    }
+    processFrames(frames);
+  }
+}
+
+// Обработка кадров: при пакетном обработчике ответы клиентам
+// накапливаются и записываются векторной записью на соединение
+void TcpServer::processFrames(std::vector<Frame>& frames) {
+  // Клиенты кадров (счётчики уменьшаются и для отклонённых кадров)
+  std::vector<Client*> owners;
+  owners.reserve(frames.size());
+  // Кадры, ожидавшие дольше target у перегруженного клиента, отклоняются
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  std::vector<Frame> accepted;
+  accepted.reserve(frames.size());
+  for(Frame& frame : frames) {
+    owners.push_back(frame.client);
+    if(!onFrameStart(*frame.client, now - frame.queued)) {
+      accepted.push_back(std::move(frame));
+      continue;
+    }
+    frame.client->access_mtx.lock();
+    reject_hndl(std::move(frame.data), *frame.client);
+    frame.client->access_mtx.unlock();
+  }
+
+  if(batch_hndl && !accepted.empty()) {
+    // Клиенты пакета блокируются в порядке адресов во избежание взаимоблокировок
+    std::vector<Client*> clients;
+    for(Frame& frame : accepted)
+      clients.push_back(frame.client);
+    std::sort(clients.begin(), clients.end());
+    clients.erase(std::unique(clients.begin(), clients.end()), clients.end());
+
+    for(Client* client : clients) {
+      client->access_mtx.lock();
+      client->beginBatch();
+    }
+    batch_hndl(accepted);
+    size_t dropped = 0;
+    for(Client* client : clients) {
+      dropped += client->flushData();
+      client->access_mtx.unlock();
+    }
+    if(dropped) {
+      std::lock_guard<std::mutex> lock(overload_mutex);
+      overload_stats.dropped_output_frames += dropped;
+    }
+  } else if(!batch_hndl) {
+    for(Frame& frame : accepted) {
+      frame.client->access_mtx.lock();
+      handler(std::move(frame.data), *frame.client);
+      frame.client->access_mtx.unlock();
+    }
+  }
+
+  // После последнего уменьшения счётчика клиент может быть удалён
+  for(Client* client : owners)
+    --client->pending_frames;
+}
+
+// Цикл потока пакетной обработки: пакет отправляется на обработку
+// при наборе max_batch кадров или через max_delay после первого кадра
+void TcpServer::batchWorkerLoop() {
+  using namespace std::chrono_literals;
+  while (_status == status::up) {
+    std::vector<Frame> frames;
+    {
+      std::unique_lock<std::mutex> lock(batch_mutex);
+      if(!batch_cv.wait_for(lock, 50ms, [this]{return !batch_queue.empty();}))
+        continue;
+      std::chrono::steady_clock::time_point deadline = batch_queue.front().queued + batch_conf.max_delay;
+      batch_cv.wait_until(lock, deadline, [this]{return batch_queue.size() >= batch_conf.max_batch;});
+      size_t count = std::min(batch_queue.size(), batch_conf.max_batch);
+      frames.reserve(count);
+      for(size_t i = 0; i < count; ++i) {
+        frames.push_back(std::move(batch_queue.front()));
+        batch_queue.pop_front();
+      }
+    }
+    processFrames(frames);
   }
 }
 
@@ -353,6 +773,115 @@ int recv_all(Socket socket, char* buffer, int size) {
     return total_received;
 }
 
+// Включение SO_BUSY_POLL для сокета в режиме низкой задержки
+// (ядро опрашивает очередь сетевой карты вместо ожидания прерывания)
+// (используется при блокирующем ожидании данных, если включён net.core.busy_poll;
+// значения выше net.core.busy_read требуют CAP_NET_ADMIN)
+void TcpServer::enableBusyPoll(Socket socket) {
+#ifdef SO_BUSY_POLL
+  if(!perf_conf.busy_poll.count()) return;
+  int busy_poll = static_cast<int>(perf_conf.busy_poll.count());
+  if(setsockopt(socket, SOL_SOCKET, SO_BUSY_POLL, &busy_poll, sizeof(busy_poll)) == -1 &&
+     !busy_poll_reported.exchange(true))
+    std::cerr << "Не удалось включить SO_BUSY_POLL: " << strerror(errno) << '\n';
+#else
+  (void)socket;
+  if(perf_conf.busy_poll.count() && !busy_poll_reported.exchange(true))
+    std::cerr << "SO_BUSY_POLL не поддерживается, используется только активное ожидание\n";
+#endif
+}
+
+// Привязка текущего потока к ядру (ошибка выводится один раз)
+void TcpServer::placeThread(int cpu) {
+  if(cpu < 0) return;
+#ifdef _WIN32
+  // Маска привязки охватывает только ядра текущей группы процессоров
+  if(cpu >= int(sizeof(DWORD_PTR) * 8)) {
+    if(!placement_reported.exchange(true))
+      std::cerr << "Не удалось привязать поток к ядру " << cpu << ": номер вне маски привязки\n";
+    return;
+  }
+  if(!SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) &&
+     !placement_reported.exchange(true))
+    std::cerr << "Не удалось привязать поток к ядру " << cpu << ": ошибка " << GetLastError() << '\n';
+#elif defined(__linux__)
+  int error = EINVAL;
+  if(cpu < CPU_SETSIZE) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu, &cpu_set);
+    error = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+  }
+  if(error && !placement_reported.exchange(true))
+    std::cerr << "Не удалось привязать поток к ядру " << cpu << ": " << strerror(error) << '\n';
+#else
+  if(!placement_reported.exchange(true))
+    std::cerr << "Привязка потоков к ядрам не поддерживается\n";
+#endif
+}
+
+// Найти NUMA узел ядра (-1 если узел неизвестен)
+static int cpuNode(int cpu) {
+#ifdef _WIN32
+  UCHAR node;
+  if(cpu < 0 || cpu > 255 || !GetNumaProcessorNode(UCHAR(cpu), &node) || node == 0xFF) return -1;
+  return node;
+#elif defined(__linux__)
+  // Узел ядра указан в sysfs ссылкой nodeN в каталоге ядра
+  std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+  DIR* dir = opendir(path.c_str());
+  if(!dir) return -1;
+  int node = -1;
+  while(dirent* entry = readdir(dir))
+    if(!strncmp(entry->d_name, "node", 4) && isdigit(entry->d_name[4])) {
+      node = atoi(entry->d_name + 4);
+      break;
+    }
+  closedir(dir);
+  return node;
+#else
+  (void)cpu;
+  return -1;
+#endif
+}
+
+// Память размещается на одном узле, поэтому при ядрах обработчиков
+// на разных узлах часть обработчиков работает с удалённой памятью
+void TcpServer::checkWorkerNodes() {
+  if(!perf_conf.numa_local || perf_conf.worker_cpus.empty()) return;
+  int node = cpuNode(perf_conf.worker_cpus.front());
+  if(node < 0) return;
+  for(int cpu : perf_conf.worker_cpus)
+    if(int cpu_node = cpuNode(cpu); cpu_node >= 0 && cpu_node != node) {
+      std::cerr << "Ядра worker_cpus находятся на разных NUMA узлах, память размещается на узле ядра "
+                << perf_conf.worker_cpus.front() << '\n';
+      return;
+    }
+}
+
+// Объекты клиентов и буферы кадров выделяются в потоках приёма подключений
+// и ожидания данных, а используются обработчиками, поэтому при numa_local
+// память этих потоков размещается на узле ядер обработчиков
+void TcpServer::placeSharedMemory() {
+  if(!perf_conf.numa_local || perf_conf.worker_cpus.empty()) return;
+#ifdef _WIN32
+  // Windows выделяет память на узле идеального процессора потока
+  SetThreadIdealProcessor(GetCurrentThread(), perf_conf.worker_cpus.front());
+#elif defined(__linux__)
+  int node = cpuNode(perf_conf.worker_cpus.front());
+  if(node < 0 || node >= int(sizeof(unsigned long) * 8)) return;
+  unsigned long node_mask = 1UL << node;
+  if(syscall(SYS_set_mempolicy, MPOL_PREFERRED, &node_mask, sizeof(node_mask) * 8 + 1) != 0)
+    std::cerr << "Не удалось разместить память на NUMA узле " << node << ": " << strerror(errno) << '\n';
+#endif
+}
+
+// Привязка потока обработчика к очередному ядру из worker_cpus
+void TcpServer::placeWorkerThread() {
+  if(perf_conf.worker_cpus.empty()) return;
+  placeThread(perf_conf.worker_cpus[next_worker_cpu++ % perf_conf.worker_cpus.size()]);
+}
+
 // Функция запуска и конфигурации Keep-Alive для сокета
 bool TcpServer::enableKeepAlive(Socket socket) {
   int flag = 1;
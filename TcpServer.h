@@ -2,9 +2,17 @@
 #define TCPSERVER_H
 
 #include "general.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <functional>
 #include <list>
+#include <memory>
+#include <string>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 #include <mutex>
 #include <shared_mutex>
 
@@ -25,6 +33,8 @@ typedef int ka_prop_t;
 #endif
 
 const size_t MAX_MESSAGE_SIZE = 1024 * 1024;
+// Лимит очереди исходящих кадров клиента по умолчанию (байт)
+const size_t DEFAULT_OUTPUT_LIMIT = 8 * 1024 * 1024;
 
 int recv_all(Socket socket, char* buffer, int size);
 
@@ -35,6 +45,73 @@ struct KeepAliveConfig{
   ka_prop_t ka_cnt = 5;
 };
 
+// Конфигурация защиты от перегрузки
+// (сброс нагрузки по времени ожидания кадров, в стиле CoDel;
+// время ожидания оценивается отдельно для каждого клиента)
+struct OverloadConfig {
+  // Включить сброс нагрузки
+  bool enabled = false;
+  // Целевое время ожидания кадра до запуска обработчика
+  std::chrono::milliseconds target{5};
+  // Интервал, за который оценивается минимальное время ожидания кадров
+  std::chrono::milliseconds interval{100};
+  // Отклонять новые кадры перегруженного клиента через обработчик вместо приостановки чтения
+  bool reject_frames = false;
+};
+
+// Метрики защиты от перегрузки
+struct OverloadStats {
+  // Сервер сейчас сбрасывает нагрузку (есть перегруженные клиенты)
+  bool shedding = false;
+  // Кол-во перегруженных клиентов
+  uint32_t shedding_clients = 0;
+  // Кол-во переходов в режим сброса нагрузки
+  uint64_t shed_events = 0;
+  // Кол-во отклонённых подключений
+  uint64_t refused_connections = 0;
+  // Кол-во приостановок чтения от перегруженных клиентов
+  uint64_t paused_reads = 0;
+  // Кол-во отклонённых кадров (при чтении и ожидавших в очереди дольше target)
+  uint64_t rejected_frames = 0;
+  // Кол-во исходящих кадров, отброшенных из-за переполнения очереди клиента
+  uint64_t dropped_output_frames = 0;
+  // Последнее измеренное время ожидания кадра
+  std::chrono::microseconds last_sojourn{0};
+};
+
+// Конфигурация пакетной обработки кадров
+struct BatchConfig {
+  // Собирать пакеты из кадров разных клиентов в рабочем потоке
+  // (иначе пакет - все кадры одного клиента за одно пробуждение)
+  bool cross_client = false;
+  // Максимальное кол-во кадров в пакете
+  size_t max_batch = 64;
+  // Максимальное ожидание заполнения пакета (только для cross_client)
+  std::chrono::microseconds max_delay{1000};
+};
+
+// Конфигурация размещения потоков и режима низкой задержки
+struct PerformanceConfig {
+  // Ядро для потока приёма подключений (-1 - без привязки)
+  int accept_cpu = -1;
+  // Ядро для потока ожидания данных (-1 - без привязки)
+  int data_loop_cpu = -1;
+  // Ядра для потоков обработчиков (назначаются по кругу).
+  // При numa_local все ядра должны быть на одном NUMA узле
+  std::vector<int> worker_cpus;
+  // Размещать память, с которой работают обработчики, на NUMA узле их ядер:
+  // объекты клиентов (поток приёма подключений) и буферы кадров (поток
+  // ожидания данных) выделяются на узле ядер worker_cpus, а память самих
+  // обработчиков выделяется локально при первом обращении
+  bool numa_local = false;
+  // Время активного ожидания данных перед блокирующим ожиданием (0 - режим выключен),
+  // так же задаёт SO_BUSY_POLL для сокетов клиентов: блокирующее ожидание (poll)
+  // опрашивает сетевую карту активно, если включён net.core.busy_poll
+  std::chrono::microseconds busy_poll{0};
+  // Максимальное время блокирующего ожидания данных
+  std::chrono::milliseconds idle_sleep{50};
+};
+
 // Класс Tcp сервера
 struct TcpServer {
   // Класс клиента сервера (реализация определена в TcpServerClient.cpp)
@@ -44,6 +121,20 @@ struct TcpServer {
   typedef std::function<void(DataBuffer, Client&)> handler_function_t;
   // Тип обработчика подключения/отсоединения клиента
   typedef std::function<void(Client&)> con_handler_function_t;
+  // Сформированный исходящий кадр (размер + данные), общий для всех получателей
+  typedef std::shared_ptr<const std::vector<char>> OutFrame;
+
+  // Кадр, передаваемый пакетному обработчику
+  struct Frame {
+    // Данные кадра (передаются без копирования)
+    DataBuffer data;
+    // Клиент, от которого получен кадр
+    Client* client;
+    // Время получения кадра
+    std::chrono::steady_clock::time_point queued;
+  };
+  // Тип пакетного обработчика данных
+  typedef std::function<void(std::vector<Frame>&)> batch_handler_function_t;
 
   // Коды статуса сервера
   enum class status : uint8_t {
@@ -72,8 +163,13 @@ private:
   std::thread accept_handler_thread;
   // Поток ожидания данных
   std::thread data_waiter_thread;
+  // Поток пакетной обработки кадров разных клиентов
+  std::thread batch_worker_thread;
   // Тип итератора клиента
   typedef std::list<std::unique_ptr<Client>>::iterator ClientIterator;
+  // Тип набора участников группы (отсортированный вектор,
+  // при изменении заменяется целиком, поэтому рассылка идёт по снимку)
+  typedef std::shared_ptr<const std::vector<Client*>> GroupMembers;
 
   // Keep-Alive конфигурация
   KeepAliveConfig ka_conf;
@@ -83,6 +179,46 @@ private:
   // Мьютекс для синхронизации потоков подключения и ожидания данных
   std::mutex client_mutex; 
 
+  // Пакетный обработчик данных (если задан, заменяет handler)
+  batch_handler_function_t batch_hndl;
+  // Конфигурация пакетной обработки
+  BatchConfig batch_conf;
+  // Очередь кадров для потока пакетной обработки
+  std::deque<Frame> batch_queue;
+  // Мьютекс очереди пакетной обработки
+  std::mutex batch_mutex;
+  // Оповещение о новых кадрах в очереди
+  std::condition_variable batch_cv;
+
+  // Конфигурация размещения потоков и режима низкой задержки
+  PerformanceConfig perf_conf;
+  // Счётчик для назначения ядер потокам обработчиков по кругу
+  std::atomic<size_t> next_worker_cpu{0};
+  // Лимит очереди исходящих кадров клиента
+  size_t output_limit = DEFAULT_OUTPUT_LIMIT;
+  // Ошибка включения SO_BUSY_POLL уже выведена
+  std::atomic<bool> busy_poll_reported{false};
+  // Ошибка привязки потока к ядру уже выведена
+  std::atomic<bool> placement_reported{false};
+
+  // Группы клиентов по топикам
+  std::unordered_map<std::string, GroupMembers> groups;
+  // Мьютекс для изменения групп
+  std::mutex group_mutex;
+
+  // Конфигурация защиты от перегрузки
+  OverloadConfig overload_conf;
+  // Обработчик кадров, отклонённых при перегрузке
+  handler_function_t reject_hndl = [](DataBuffer, Client&){};
+  // Мьютекс состояния детектора перегрузки
+  std::mutex overload_mutex;
+  // Метрики защиты от перегрузки
+  OverloadStats overload_stats;
+  // Кол-во перегруженных клиентов (при ненулевом новые подключения не принимаются)
+  std::atomic<uint32_t> shedding_clients{0};
+  // Время последней проверки интервалов оценки клиентов
+  std::chrono::steady_clock::time_point last_overload_check;
+
   // Для систем Windows так же требуется
   // структура определяющая версию WinSocket
 #ifdef _WIN32 // Windows NT
@@ -95,6 +231,32 @@ private:
   void handlingAcceptLoop();
   // Метод ожидания данных
   void waitingDataLoop();
+  // Настроить сокет клиента для режима низкой задержки
+  void enableBusyPoll(Socket socket);
+  // Привязать текущий поток к ядру
+  void placeThread(int cpu);
+  // Проверить, что ядра обработчиков находятся на одном NUMA узле
+  void checkWorkerNodes();
+  // Разместить память текущего потока на NUMA узле обработчиков
+  void placeSharedMemory();
+  // Привязать текущий поток к очередному ядру обработчиков
+  void placeWorkerThread();
+  // Исключить клиента из всех групп
+  void leaveAll(Client& client);
+  // Учесть время ожидания кадра перед запуском обработчика
+  // (true - кадр ожидал слишком долго и должен быть отклонён)
+  bool onFrameStart(Client& client, std::chrono::steady_clock::duration sojourn);
+  // Завершить интервал оценки клиента, если он истёк (под overload_mutex)
+  void checkOverload(Client& client, std::chrono::steady_clock::time_point now);
+  // Поставить поступившие кадры клиента в очередь обработки
+  // (при пакетном обработчике дочитываются все полностью поступившие кадры)
+  void dispatchFrames(Client& client, DataBuffer data);
+  // Метод потока обработки кадров клиента (один поток на клиента, кадры по порядку)
+  void clientWorkerLoop(Client& client);
+  // Обработать кадры обработчиком данных или пакетным обработчиком
+  void processFrames(std::vector<Frame>& frames);
+  // Метод потока пакетной обработки
+  void batchWorkerLoop();
 
 public:
   // Упрощённый конструктор с указанием:
@@ -121,6 +283,22 @@ public:
 
   // Заменить обработчик данных
   void setHandler(handler_function_t handler);
+  // Задать пакетный обработчик данных (до запуска сервера)
+  void setBatchHandler(batch_handler_function_t batch_hndl, BatchConfig batch_conf = {});
+  // Задать конфигурацию защиты от перегрузки (до запуска сервера)
+  void setOverloadConfig(OverloadConfig overload_conf);
+  // Задать обработчик кадров, отклонённых при перегрузке (до запуска сервера).
+  // При reject_frames вызывается в потоке ожидания данных, поэтому
+  // не должен блокироваться; устаревшие кадры из очереди отклоняются
+  // в потоке обработки клиента
+  void setRejectHandler(handler_function_t reject_hndl);
+  // Получить метрики защиты от перегрузки
+  OverloadStats getOverloadStats();
+  // Задать конфигурацию размещения потоков и режима низкой задержки (до запуска сервера)
+  void setPerformanceConfig(PerformanceConfig perf_conf);
+  // Задать лимит очереди исходящих кадров клиента в байтах (до запуска сервера).
+  // Кадры рассылок и ответов пакетного обработчика сверх лимита отбрасываются
+  void setOutputLimit(size_t output_limit);
   // Getter порта
   uint16_t getPort() const;
   // Setter порта
@@ -141,6 +319,16 @@ public:
   void sendData(const void* buffer, const size_t size);
   // Отправить данные клиенту по порту и хосту
   bool sendDataBy(uint32_t host, uint16_t port, const void* buffer, const size_t size);
+  // Добавить клиента в группу топика
+  bool join(Client& client, const std::string& topic);
+  // Исключить клиента из группы топика
+  bool leave(Client& client, const std::string& topic);
+  // Отправить данные всем клиентам группы топика
+  // (возвращает кол-во клиентов, которым данные были отправлены;
+  // skip_hndl вызывается для отключённых участников и участников
+  // с переполненной очередью, которым кадр не был отправлен)
+  size_t publish(const std::string& topic, const void* buffer, const size_t size,
+                 con_handler_function_t skip_hndl = nullptr);
   // Отключить клиента по порту и хосту
   bool disconnectBy(uint32_t host, uint16_t port);
   // Отключить всех клиентов
@@ -159,6 +347,86 @@ struct TcpServer::Client : public TcpClientBase {
   Socket socket;
   // Код статуса клиента
   status _status = status::connected;
+  // Кол-во кадров клиента, ожидающих или проходящих обработку
+  std::atomic<uint32_t> pending_frames{0};
+  // Удаление отключённого клиента уже запущено (под client_mutex сервера)
+  bool cleanup_scheduled = false;
+  // Чтение от клиента приостановлено при перегрузке (под client_mutex сервера)
+  bool reads_paused = false;
+  // Клиент перегружен: минимальное время ожидания его кадров за интервал не ниже target
+  std::atomic<bool> overloaded{false};
+  // Кол-во кадров в очереди, ещё не переданных обработчику
+  std::atomic<uint32_t> queued_frames{0};
+  // Начало текущего интервала оценки (под overload_mutex сервера)
+  std::chrono::steady_clock::time_point interval_start = std::chrono::steady_clock::now();
+  // Минимальное время ожидания кадра за текущий интервал (под overload_mutex сервера)
+  std::chrono::steady_clock::duration interval_min = std::chrono::steady_clock::duration::max();
+  // Топики, в группах которых состоит клиент (под group_mutex сервера)
+  std::vector<std::string> topics;
+  // Кол-во рассылок, использующих клиента (удаление ожидает обнуления)
+  std::atomic<uint32_t> publish_refs{0};
+
+  // Мьютекс записи в сокет (кадры разных потоков не перемешиваются)
+  mutable std::mutex send_mtx;
+  // Мьютекс очереди исходящих кадров
+  mutable std::mutex queue_mtx;
+  // Исходящие кадры, ещё не записанные в сокет
+  mutable std::deque<OutFrame> out_queue;
+  // Кол-во уже записанных байт первого кадра очереди
+  mutable size_t out_offset = 0;
+  // Суммарный размер кадров очереди
+  mutable size_t out_bytes = 0;
+  // Лимит суммарного размера кадров очереди
+  size_t output_limit = DEFAULT_OUTPUT_LIMIT;
+  // В очереди есть незаписанные кадры
+  mutable std::atomic<bool> has_output{false};
+
+  // Поставить готовый кадр в очередь и записать без блокировки сколько возможно
+  // (false - клиент отключён или кадр отброшен из-за переполнения очереди)
+  bool sendFrame(OutFrame frame) const;
+  // Поставить кадр в очередь (limited - отбросить кадр при превышении лимита)
+  bool queueFrame(OutFrame frame, bool limited = false) const;
+  // Записать очередь в сокет (под send_mtx); wait - дождаться записи всей очереди
+  bool writeQueue(bool wait) const;
+  // Дописать очередь без блокировки, если запись не занята другим потоком
+  void flushQueue() const;
+
+  // Мьютекс очереди входящих кадров
+  std::mutex in_mtx;
+  // Кадры клиента, ожидающие обработки (под in_mtx)
+  std::deque<Frame> in_queue;
+  // Поток обработки кадров клиента запущен (под in_mtx)
+  bool worker_active = false;
+
+  // Мьютекс кадров, накопленных во время пакетной обработки
+  mutable std::mutex out_mtx;
+  // Исходящие кадры, накопленные во время пакетной обработки
+  mutable std::vector<OutFrame> batch_frames;
+  // Режим накопления исходящих кадров
+  bool batching = false;
+
+  // Размер принимаемого кадра (в сетевом порядке байт)
+  uint32_t in_size = 0;
+  // Кол-во принятых байт размера кадра
+  size_t in_header_received = 0;
+  // Данные принимаемого кадра
+  DataBuffer in_buffer;
+  // Кол-во принятых байт данных кадра
+  int in_received = 0;
+
+  // Начать накопление исходящих кадров
+  void beginBatch();
+  // Поставить накопленные кадры в очередь и записать без блокировки
+  // (остаток дописывает поток ожидания данных; возвращает кол-во
+  // кадров, отброшенных из-за переполнения очереди)
+  size_t flushData();
+  // Нет кадров, ожидающих обработки, и поток обработки завершён
+  bool isIdle();
+  // Есть ли данные для чтения без блокировки
+  bool hasData() const;
+  // Получить кадр из уже поступивших данных без блокировки
+  // (неполный кадр сохраняется до поступления остальных данных)
+  DataBuffer loadReadyData();
 
 public:
   // Конструктор с указанием:
@@ -1,6 +1,16 @@
 // TcpServerClient.cpp
 #include "TcpServer.h"
+#include <algorithm>
 #include <iostream>
+#ifndef _WIN32
+#include <cerrno>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
+#endif
+
+// Максимальное кол-во кадров очереди в одном вызове записи
+const size_t MAX_WRITE_FRAMES = 64;
 
 // Конструктор клиента
 TcpServer::Client::Client(Socket socket, SocketAddr_in address)
@@ -97,14 +107,268 @@ bool TcpServer::Client::sendData(const void* buffer, const size_t size) const {
     // Если сокет закрыт вернуть false
     if(_status != SocketStatus::connected) return false;
 
-    // Отправляем размер сообщения
+    // Формируем кадр (размер + сообщение) одним буфером
     uint32_t net_size = htonl(static_cast<uint32_t>(size));
-    if(send(socket, reinterpret_cast<const char*>(&net_size), sizeof(net_size), 0) <= 0)
-        return false;
+    std::shared_ptr<std::vector<char>> frame = std::make_shared<std::vector<char>>(sizeof(net_size) + size);
+    memcpy(frame->data(), &net_size, sizeof(net_size));
+    memcpy(frame->data() + sizeof(net_size), buffer, size);
 
-    // Отправляем само сообщение
-    if(send(socket, reinterpret_cast<const char*>(buffer), size, 0) <= 0)
-        return false;
+    // Во время пакетной обработки кадр откладывается до flushData
+    {
+      std::lock_guard<std::mutex> lock(out_mtx);
+      if(batching) {
+        batch_frames.push_back(std::move(frame));
+        return true;
+      }
+    }
 
+    // Записываем его после ранее поставленных в очередь кадров
+    queueFrame(frame);
+    std::lock_guard<std::mutex> lock(send_mtx);
+    return writeQueue(true);
+}
+
+// Поставить клиенту готовый кадр в очередь и записать без блокировки
+bool TcpServer::Client::sendFrame(OutFrame frame) const {
+    if(_status != SocketStatus::connected) return false;
+    {
+      std::lock_guard<std::mutex> lock(out_mtx);
+      if(batching) {
+        batch_frames.push_back(std::move(frame));
+        return true;
+      }
+    }
+    if(!queueFrame(std::move(frame), true)) return false;
+    flushQueue();
     return true;
 }
+
+// Поставить кадр в очередь исходящих кадров.
+// При limited кадр, с которым очередь превысит лимит, отбрасывается
+// (в пустую очередь кадр ставится всегда)
+bool TcpServer::Client::queueFrame(OutFrame frame, bool limited) const {
+    std::lock_guard<std::mutex> lock(queue_mtx);
+    if(limited && out_bytes && out_bytes + frame->size() > output_limit)
+      return false;
+    out_bytes += frame->size();
+    out_queue.push_back(std::move(frame));
+    has_output = true;
+    return true;
+}
+
+// Дописать очередь, если в сокет сейчас не пишет другой поток
+// (он сам запишет поставленные кадры)
+void TcpServer::Client::flushQueue() const {
+    std::unique_lock<std::mutex> lock(send_mtx, std::try_to_lock);
+    if(lock.owns_lock()) writeQueue(false);
+}
+
+// Записать очередь в сокет векторной записью.
+// Вызывается под send_mtx, поэтому кадры удаляет из очереди только этот поток
+bool TcpServer::Client::writeQueue(bool wait) const {
+    while(true) {
+      // Собрать буферы ещё не записанных кадров
+#ifdef _WIN32
+      WSABUF buffers[MAX_WRITE_FRAMES];
+#else
+      iovec buffers[MAX_WRITE_FRAMES];
+#endif
+      size_t count = 0;
+      {
+        std::lock_guard<std::mutex> lock(queue_mtx);
+        if(out_queue.empty()) {
+          has_output = false;
+          return true;
+        }
+        if(_status != SocketStatus::connected) {
+          out_queue.clear();
+          out_offset = 0;
+          out_bytes = 0;
+          has_output = false;
+          return false;
+        }
+        for(auto it = out_queue.begin(); it != out_queue.end() && count < MAX_WRITE_FRAMES; ++it, ++count) {
+          size_t offset = count ? 0 : out_offset;
+#ifdef _WIN32
+          buffers[count].buf = const_cast<char*>((*it)->data()) + offset;
+          buffers[count].len = static_cast<ULONG>((*it)->size() - offset);
+#else
+          buffers[count].iov_base = const_cast<char*>((*it)->data()) + offset;
+          buffers[count].iov_len = (*it)->size() - offset;
+#endif
+        }
+      }
+
+      size_t sended = 0;
+#ifdef _WIN32
+      // Для неблокирующей записи сокет на время вызова
+      // переводится в неблокирующий режим
+      u_long non_blocking = 1, blocking = 0;
+      if(!wait) ioctlsocket(socket, FIONBIO, &non_blocking);
+      DWORD bytes = 0;
+      int result = WSASend(socket, buffers, static_cast<DWORD>(count), &bytes, 0, nullptr, nullptr);
+      int error = result == SOCKET_ERROR ? WSAGetLastError() : 0;
+      if(!wait) ioctlsocket(socket, FIONBIO, &blocking);
+      if(result == SOCKET_ERROR) {
+        if(!wait && error == WSAEWOULDBLOCK) return true;
+        std::lock_guard<std::mutex> lock(queue_mtx);
+        out_queue.clear();
+        out_offset = 0;
+        out_bytes = 0;
+        has_output = false;
+        return false;
+      }
+      sended = bytes;
+#else
+      msghdr msg{};
+      msg.msg_iov = buffers;
+      msg.msg_iovlen = count;
+      ssize_t bytes = sendmsg(socket, &msg, wait ? 0 : MSG_DONTWAIT);
+      if(bytes < 0) {
+        if(!wait && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        std::lock_guard<std::mutex> lock(queue_mtx);
+        out_queue.clear();
+        out_offset = 0;
+        out_bytes = 0;
+        has_output = false;
+        return false;
+      }
+      sended = static_cast<size_t>(bytes);
+#endif
+
+      // Удалить полностью записанные кадры
+      std::lock_guard<std::mutex> lock(queue_mtx);
+      while(sended) {
+        size_t rest = out_queue.front()->size() - out_offset;
+        if(sended < rest) {
+          out_offset += sended;
+          break;
+        }
+        sended -= rest;
+        out_bytes -= out_queue.front()->size();
+        out_queue.pop_front();
+        out_offset = 0;
+      }
+    }
+}
+
+// Начать накопление исходящих кадров
+void TcpServer::Client::beginBatch() {
+    std::lock_guard<std::mutex> lock(out_mtx);
+    batching = true;
+}
+
+// Поставить накопленные кадры в очередь и записать их без блокировки
+// (кадры не склеиваются, а передаются в одну векторную запись;
+// незаписанный остаток дописывает поток ожидания данных).
+// Кадры сверх лимита очереди отбрасываются
+size_t TcpServer::Client::flushData() {
+    std::vector<OutFrame> frames;
+    {
+      std::lock_guard<std::mutex> lock(out_mtx);
+      batching = false;
+      frames.swap(batch_frames);
+    }
+    if(frames.empty() || _status != SocketStatus::connected) return 0;
+    size_t dropped = 0;
+    for(OutFrame& frame : frames)
+      if(!queueFrame(std::move(frame), true))
+        ++dropped;
+    flushQueue();
+    return dropped;
+}
+
+// Проверить, что очередь входящих кадров пуста и поток обработки завершён
+bool TcpServer::Client::isIdle() {
+    std::lock_guard<std::mutex> lock(in_mtx);
+    return !worker_active && in_queue.empty();
+}
+
+// Проверить готовность сокета к чтению без блокировки
+// (закрытие соединения так же считается готовностью)
+bool TcpServer::Client::hasData() const {
+    if(_status != SocketStatus::connected) return false;
+    pollfd fd{socket, POLLIN, 0};
+#ifdef _WIN32
+    return WSAPoll(&fd, 1, 0) > 0;
+#else
+    return poll(&fd, 1, 0) > 0;
+#endif
+}
+
+// Получить кадр из уже поступивших данных без блокировки
+DataBuffer TcpServer::Client::loadReadyData() {
+  while(_status == SocketStatus::connected) {
+    // Кол-во байт, доступных для чтения без блокировки
+#ifdef _WIN32
+    u_long available = 0;
+    if(ioctlsocket(socket, FIONREAD, &available) != 0) {
+#else
+    int available = 0;
+    if(ioctl(socket, FIONREAD, &available) != 0) {
+#endif
+      disconnect();
+      break;
+    }
+    if(!available) {
+      // Признак закрытия соединения - неблокирующее чтение, вернувшее 0
+      char byte;
+#ifdef _WIN32
+      // Готовый к чтению сокет не блокирует recv
+      if(!hasData()) break;
+      int received = recv(socket, &byte, 1, MSG_PEEK);
+      bool would_block = received < 0 && WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+      int received = recv(socket, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+      bool would_block = received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+#endif
+      if(received > 0) continue;
+      if(!would_block) disconnect();
+      break;
+    }
+
+    // Получение размера сообщения
+    if(in_header_received < sizeof(in_size)) {
+      int received = recv(socket, reinterpret_cast<char*>(&in_size) + in_header_received,
+                          std::min<size_t>(available, sizeof(in_size) - in_header_received), 0);
+      if(received <= 0) {
+        disconnect();
+        break;
+      }
+      in_header_received += received;
+      if(in_header_received < sizeof(in_size)) break;
+
+      uint32_t size = ntohl(in_size);
+      if(!size || size > MAX_MESSAGE_SIZE) {
+        disconnect();
+        break;
+      }
+      in_buffer.size = size;
+      in_buffer.data_ptr = malloc(size);
+      if(!in_buffer.data_ptr) {
+        std::cerr << "Не удалось выделить память для данных.\n";
+        disconnect();
+        break;
+      }
+      in_received = 0;
+      continue;
+    }
+
+    // Получение самого сообщения
+    int received = recv(socket, reinterpret_cast<char*>(in_buffer.data_ptr) + in_received,
+                        std::min<size_t>(available, in_buffer.size - in_received), 0);
+    if(received <= 0) {
+      disconnect();
+      break;
+    }
+    in_received += received;
+    if(in_received < in_buffer.size) break;
+
+    // Кадр получен полностью
+    DataBuffer buffer(std::move(in_buffer));
+    in_buffer.size = 0;
+    in_header_received = 0;
+    return buffer;
+  }
+  return DataBuffer();
+}
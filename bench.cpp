@@ -0,0 +1,190 @@
+// Нагрузочный тест сервера: задержка запрос-ответ (p50/p99) и
+// затраты CPU на запрос при разных настройках PerformanceConfig.
+// Сборка: g++ -O2 TcpServer.cpp TcpServerClient.cpp bench.cpp -o bench.exe -lws2_32
+// Запуск: bench.exe [кол-во клиентов] [запросов на клиента] [IP сервера]
+// (IP сервера должен совпадать с адресом, который слушает TcpServer::start;
+// по умолчанию BENCH_HOST)
+#include <iostream>
+#include <algorithm>
+#include <iomanip>
+#include "TcpServer.h"
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+// IP-адрес, который слушает сервер (см. TcpServer::start;
+// при изменении адреса в TcpServer::start изменить и здесь)
+const char* BENCH_HOST = "192.168.100.103";
+// Первый порт сервера (у каждого сценария свой порт)
+const uint16_t BENCH_PORT = 9100;
+// Размер полезной нагрузки запроса
+const size_t PAYLOAD_SIZE = 64;
+
+// Сценарий нагрузочного теста
+struct Scenario {
+  std::string name;
+  PerformanceConfig conf;
+};
+
+// Процессорное время процесса (сервер + клиенты теста) в секундах
+double processCpuTime() {
+#ifdef _WIN32
+  FILETIME creation, exit, kernel, user;
+  GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+  auto to_seconds = [](FILETIME time) {
+    return double((uint64_t(time.dwHighDateTime) << 32) | time.dwLowDateTime) / 1e7;
+  };
+  return to_seconds(kernel) + to_seconds(user);
+#else
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+         (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+#endif
+}
+
+// Подключиться к серверу
+Socket connectToServer(uint32_t host, uint16_t port) {
+  Socket client_socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  SocketAddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = host;
+  address.sin_port = htons(port);
+  if(connect(client_socket, (sockaddr*)&address, sizeof(address)) != 0) {
+#ifdef _WIN32
+    closesocket(client_socket);
+    return INVALID_SOCKET;
+#else
+    close(client_socket);
+    return -1;
+#endif
+  }
+  return client_socket;
+}
+
+// Прогнать сценарий: каждый клиент последовательно отправляет
+// запросы и ждёт эхо-ответ, время ответа записывается
+bool runScenario(const Scenario& scenario, uint16_t port, uint32_t host,
+                 size_t clients, size_t requests) {
+  TcpServer server(port, [](DataBuffer data, TcpServer::Client& client) {
+    client.sendData(data.data_ptr, data.size);
+  });
+  server.setPerformanceConfig(scenario.conf);
+  if(server.start() != TcpServer::status::up) {
+    std::cout << scenario.name << ": ошибка запуска сервера " << int(server.getStatus()) << '\n';
+    return false;
+  }
+
+  std::vector<Socket> sockets;
+  for(size_t i = 0; i < clients; ++i) {
+    Socket client_socket = connectToServer(host, port);
+    if(client_socket ==
+#ifdef _WIN32
+       INVALID_SOCKET
+#else
+       -1
+#endif
+       ) {
+      std::cout << scenario.name << ": ошибка подключения\n";
+      server.stop();
+      return false;
+    }
+    sockets.push_back(client_socket);
+  }
+
+  std::vector<std::vector<double>> latencies(clients);
+  double cpu_start = processCpuTime();
+  std::chrono::steady_clock::time_point wall_start = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> threads;
+  for(size_t i = 0; i < clients; ++i)
+    threads.emplace_back([&, i] {
+      std::vector<char> request(sizeof(uint32_t) + PAYLOAD_SIZE, 'x');
+      uint32_t net_size = htonl(PAYLOAD_SIZE);
+      memcpy(request.data(), &net_size, sizeof(net_size));
+      std::vector<char> reply(request.size());
+      latencies[i].reserve(requests);
+      for(size_t r = 0; r < requests; ++r) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        if(send(sockets[i], request.data(), request.size(), 0) <= 0) return;
+        if(recv_all(sockets[i], reply.data(), reply.size()) <= 0) return;
+        latencies[i].push_back(std::chrono::duration<double, std::micro>(
+                                 std::chrono::steady_clock::now() - start).count());
+      }
+    });
+  for(std::thread& thread : threads) thread.join();
+
+  double wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+  double cpu_time = processCpuTime() - cpu_start;
+
+  std::vector<double> all;
+  for(std::vector<double>& client_latencies : latencies)
+    all.insert(all.end(), client_latencies.begin(), client_latencies.end());
+  std::sort(all.begin(), all.end());
+
+  if(all.empty()) {
+    std::cout << scenario.name << ": нет ответов\n";
+  } else {
+    std::cout << std::left << std::setw(20) << scenario.name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << all[all.size() / 2]
+              << std::setw(10) << all[std::min(all.size() - 1, all.size() * 99 / 100)]
+              << std::setw(12) << all.size() / wall_time
+              << std::setw(12) << cpu_time * 1e6 / all.size() << '\n';
+  }
+
+  for(Socket client_socket : sockets) {
+#ifdef _WIN32
+    closesocket(client_socket);
+#else
+    close(client_socket);
+#endif
+  }
+  // Дать серверу обработать отключения
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  server.stop();
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  size_t clients = argc > 1 ? std::stoul(argv[1]) : 4;
+  size_t requests = argc > 2 ? std::stoul(argv[2]) : 10000;
+  // Адрес подключения: сервер теста слушает адрес из TcpServer::start,
+  // поэтому аргумент нужен, только если там задан другой адрес
+  uint32_t host = inet_addr(argc > 3 ? argv[3] : BENCH_HOST);
+
+  // Ядра для сценариев с привязкой: 0 - приём подключений,
+  // 1 - ожидание данных, остальные - обработчики
+  int cores = std::max(1u, std::thread::hardware_concurrency());
+  PerformanceConfig pinned;
+  pinned.accept_cpu = 0;
+  pinned.data_loop_cpu = 1 % cores;
+  for(int cpu = 2; cpu < cores; ++cpu) pinned.worker_cpus.push_back(cpu);
+  if(pinned.worker_cpus.empty()) pinned.worker_cpus.push_back(cores - 1);
+
+  PerformanceConfig pinned_numa = pinned;
+  pinned_numa.numa_local = true;
+
+  PerformanceConfig busy_poll;
+  busy_poll.busy_poll = std::chrono::microseconds(50);
+
+  PerformanceConfig pinned_busy_poll = pinned_numa;
+  pinned_busy_poll.busy_poll = std::chrono::microseconds(50);
+
+  std::vector<Scenario> scenarios = {
+    {"default", PerformanceConfig{}},
+    {"pinned", pinned},
+    {"pinned+numa", pinned_numa},
+    {"busy-poll 50us", busy_poll},
+    {"pinned+busy-poll", pinned_busy_poll},
+  };
+
+  std::cout << "Клиентов: " << clients << ", запросов на клиента: " << requests << '\n'
+            << "CPU - время процесса (сервер + клиенты теста) на запрос\n"
+            // (заголовок выровнен вручную: setw считает байты, а не символы UTF-8)
+            << "сценарий               p50 мкс   p99 мкс      запр/с     CPU мкс\n";
+
+  for(size_t i = 0; i < scenarios.size(); ++i)
+    runScenario(scenarios[i], uint16_t(BENCH_PORT + i), host, clients, requests);
+  return 0;
+}
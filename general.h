@@ -39,7 +39,7 @@ struct DataBuffer {
   DataBuffer() = default;
   DataBuffer(int size, void* data_ptr) : size(size), data_ptr(data_ptr) {}
   DataBuffer(const DataBuffer& other) : size(other.size), data_ptr(malloc(size)) {memcpy(data_ptr, other.data_ptr, size);}
-  DataBuffer(DataBuffer&& other) : size(other.size), data_ptr(other.data_ptr) {other.data_ptr = nullptr;}
+  DataBuffer(DataBuffer&& other) noexcept : size(other.size), data_ptr(other.data_ptr) {other.data_ptr = nullptr;}
   ~DataBuffer() {if(data_ptr) free(data_ptr); data_ptr = nullptr;}
 
   bool isEmpty() {return !data_ptr || !size;}